@@ -177,6 +177,71 @@ TEST_F(ConsensusMetadataTest, TestFlush) {
   }
 }
 
+// Test that Flush() skips the on-disk write when the metadata is unchanged
+// since the last flush, and that any mutation in between forces a rewrite.
+TEST_F(ConsensusMetadataTest, TestFlushSkippedWhenUnchanged) {
+  scoped_refptr<ConsensusMetadata> cmeta;
+  ASSERT_OK(ConsensusMetadata::Create(&fs_manager_, kTabletId, fs_manager_.uuid(),
+                                      config_, kInitialTerm,
+                                      ConsensusMetadataCreateMode::FLUSH_ON_CREATE,
+                                      &cmeta));
+  int64_t calls_before = cmeta->flush_count_for_tests();
+  int64_t writes_before = cmeta->flush_write_count_for_tests();
+
+  // Flushing twice with no mutation in between should not rewrite the file,
+  // but the calls must still be counted.
+  ASSERT_OK(cmeta->Flush());
+  ASSERT_OK(cmeta->Flush());
+  ASSERT_EQ(calls_before + 2, cmeta->flush_count_for_tests());
+  ASSERT_EQ(writes_before, cmeta->flush_write_count_for_tests());
+
+  // A mutation between flushes must cause a rewrite...
+  cmeta->set_current_term(kInitialTerm + 1);
+  ASSERT_OK(cmeta->Flush());
+  ASSERT_EQ(writes_before + 1, cmeta->flush_write_count_for_tests());
+
+  // ... and the new term must be durably visible to a fresh Load().
+  {
+    scoped_refptr<ConsensusMetadata> cmeta_read;
+    ASSERT_OK(ConsensusMetadata::Load(&fs_manager_, kTabletId, fs_manager_.uuid(), &cmeta_read));
+    NO_FATALS(AssertValuesEqual(cmeta_read, kInvalidOpIdIndex, fs_manager_.uuid(),
+                                kInitialTerm + 1));
+  }
+
+  // Once the mutation has been flushed, flushing again skips once more.
+  ASSERT_OK(cmeta->Flush());
+  ASSERT_EQ(writes_before + 1, cmeta->flush_write_count_for_tests());
+}
+
+// Like the above, but exercise the interaction with Load(): a freshly loaded
+// cmeta matches the on-disk state, so an immediate Flush() must skip the
+// write, while a mutation after loading must still hit the disk.
+TEST_F(ConsensusMetadataTest, TestFlushSkippedWhenUnchangedAfterLoad) {
+  ASSERT_OK(ConsensusMetadata::Create(&fs_manager_, kTabletId, fs_manager_.uuid(),
+                                      config_, kInitialTerm));
+
+  scoped_refptr<ConsensusMetadata> cmeta;
+  ASSERT_OK(ConsensusMetadata::Load(&fs_manager_, kTabletId, fs_manager_.uuid(), &cmeta));
+  ASSERT_EQ(0, cmeta->flush_write_count_for_tests());
+
+  // The loaded state matches what's on disk, so this flush is a no-op
+  // write-wise.
+  ASSERT_OK(cmeta->Flush());
+  ASSERT_EQ(1, cmeta->flush_count_for_tests());
+  ASSERT_EQ(0, cmeta->flush_write_count_for_tests());
+
+  // A mutation after loading must be written out.
+  cmeta->set_voted_for(fs_manager_.uuid());
+  ASSERT_OK(cmeta->Flush());
+  ASSERT_EQ(1, cmeta->flush_write_count_for_tests());
+  {
+    scoped_refptr<ConsensusMetadata> cmeta_read;
+    ASSERT_OK(ConsensusMetadata::Load(&fs_manager_, kTabletId, fs_manager_.uuid(), &cmeta_read));
+    ASSERT_TRUE(cmeta_read->has_voted_for());
+    ASSERT_EQ(fs_manager_.uuid(), cmeta_read->voted_for());
+  }
+}
+
 // Builds a distributed configuration of voters with the given uuids.
 RaftConfigPB BuildConfig(const vector<string>& uuids) {
   RaftConfigPB config;
@@ -16,6 +16,7 @@
 // under the License.
 #include "kudu/consensus/consensus_meta.h"
 
+#include <atomic>
 #include <cstddef>
 #include <limits>
 #include <ostream>
@@ -90,26 +91,34 @@ uint64_t PackRoleAndTerm(RaftPeerPB::Role role, int64_t term) {
   // gracefully at a higher level (e.g., the server marks corresponding replica
   // as failed). With current approach, the maximum acceptable term is
   // 2305843009213693950; 2305843009213693951 (kTermMask) is a special value.
-  if (PREDICT_FALSE((term & kRoleMask) != 0)) {
-    // A special value to signal that a 'non-packable' term was supplied.
-    term = kTermMask;
-  }
+  // The substitutions below are written as branchless mask-selects
+  // ('mask' is all-ones when the special value is needed, all-zeroes
+  // otherwise) since this function runs on every setter call and the
+  // special cases are rare enough that a branch would be wasted space
+  // in the predictor.
+  uint64_t t = static_cast<uint64_t>(term);
+  // A special value to signal that a 'non-packable' term was supplied.
+  const uint64_t term_overflow = -static_cast<uint64_t>((t & kRoleMask) != 0);
+  t = (t & ~term_overflow) | (kTermMask & term_overflow);
 
   // The allocated bit space for role is just 3 bits, but it's necessary
   // to handle the constant 999 defined in the proto file for UNKNOWN_ROLE.
   // Changing the constant behind UNKNOWN_ROLE is not an option
   // due to compatibility issues.
-  uint64_t r = (role == RaftPeerPB::UNKNOWN_ROLE) ? kUnknownRolePacked
-                                                  : static_cast<uint64_t>(role);
-  return (r << kPackedTermBits) | term;
+  uint64_t r = static_cast<uint64_t>(role);
+  const uint64_t role_overflow = -static_cast<uint64_t>((r & ~kUnknownRolePacked) != 0);
+  r = (r & ~role_overflow) | (kUnknownRolePacked & role_overflow);
+  return (r << kPackedTermBits) | t;
 }
 
 RaftPeerPB::Role UnpackRole(uint64_t role_and_term_packed) {
-  const auto role = role_and_term_packed >> kPackedTermBits;
-  if (PREDICT_FALSE(role == kUnknownRolePacked)) {
-    return RaftPeerPB::UNKNOWN_ROLE;
-  }
-  return static_cast<RaftPeerPB::Role>(role);
+  const uint64_t role = role_and_term_packed >> kPackedTermBits;
+  // Map the packed sentinel back to UNKNOWN_ROLE (999) without a branch;
+  // see PackRoleAndTerm() above.
+  const uint64_t is_unknown = -static_cast<uint64_t>(role == kUnknownRolePacked);
+  return static_cast<RaftPeerPB::Role>(
+      (role & ~is_unknown) |
+      (static_cast<uint64_t>(RaftPeerPB::UNKNOWN_ROLE) & is_unknown));
 }
 
 int64_t UnpackTerm(uint64_t role_and_term_packed) {
@@ -123,7 +132,6 @@ int64_t UnpackTerm(uint64_t role_and_term_packed) {
 } // anonymous namespace
 
 int64_t ConsensusMetadata::current_term() const {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
   DCHECK(pb_.has_current_term());
   return pb_.current_term();
 }
@@ -136,12 +144,10 @@ void ConsensusMetadata::set_current_term(int64_t term) {
 }
 
 bool ConsensusMetadata::has_voted_for() const {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
   return pb_.has_voted_for();
 }
 
 const string& ConsensusMetadata::voted_for() const {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
   DCHECK(pb_.has_voted_for());
   return pb_.voted_for();
 }
@@ -158,46 +164,32 @@ void ConsensusMetadata::set_voted_for(const string& uuid) {
 }
 
 bool ConsensusMetadata::IsVoterInConfig(const string& uuid,
-                                        RaftConfigState type) {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
+                                        RaftConfigState type) const {
   return IsRaftConfigVoter(uuid, GetConfig(type));
 }
 
 bool ConsensusMetadata::IsMemberInConfig(const string& uuid,
-                                         RaftConfigState type) {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
+                                         RaftConfigState type) const {
   return IsRaftConfigMember(uuid, GetConfig(type));
 }
 
-int ConsensusMetadata::CountVotersInConfig(RaftConfigState type) {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
+int ConsensusMetadata::CountVotersInConfig(RaftConfigState type) const {
   return CountVoters(GetConfig(type));
 }
 
-int64_t ConsensusMetadata::GetConfigOpIdIndex(RaftConfigState type) {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
+int64_t ConsensusMetadata::GetConfigOpIdIndex(RaftConfigState type) const {
   return GetConfig(type).opid_index();
 }
 
 const RaftConfigPB& ConsensusMetadata::CommittedConfig() const {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
-  return GetConfig(COMMITTED_CONFIG);
+  return committed_config();
 }
 
 const RaftConfigPB& ConsensusMetadata::GetConfig(RaftConfigState type) const {
   switch (type) {
-    case ACTIVE_CONFIG:
-      if (has_pending_config_) {
-        return pending_config_;
-      }
-      DCHECK(pb_.has_committed_config());
-      return pb_.committed_config();
-    case COMMITTED_CONFIG:
-      DCHECK(pb_.has_committed_config());
-      return pb_.committed_config();
-    case PENDING_CONFIG:
-      CHECK(has_pending_config_) << LogPrefix() << "There is no pending config";
-      return pending_config_;
+    case ACTIVE_CONFIG: return active_config();
+    case COMMITTED_CONFIG: return committed_config();
+    case PENDING_CONFIG: return pending_config();
     default: LOG(FATAL) << "Unknown RaftConfigState type: " << type;
   }
 }
@@ -211,13 +203,11 @@ void ConsensusMetadata::set_committed_config(const RaftConfigPB& config) {
 }
 
 bool ConsensusMetadata::has_pending_config() const {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
   return has_pending_config_;
 }
 
 const RaftConfigPB& ConsensusMetadata::PendingConfig() const {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
-  return GetConfig(PENDING_CONFIG);
+  return pending_config();
 }
 
 void ConsensusMetadata::clear_pending_config() {
@@ -235,12 +225,10 @@ void ConsensusMetadata::set_pending_config(const RaftConfigPB& config) {
 }
 
 const RaftConfigPB& ConsensusMetadata::ActiveConfig() const {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
-  return GetConfig(ACTIVE_CONFIG);
+  return active_config();
 }
 
 const string& ConsensusMetadata::leader_uuid() const {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
   return leader_uuid_;
 }
 
@@ -251,22 +239,25 @@ void ConsensusMetadata::set_leader_uuid(string uuid) {
 }
 
 RaftPeerPB::Role ConsensusMetadata::active_role() const {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
   return active_role_;
 }
 
 ConsensusStatePB ConsensusMetadata::ToConsensusStatePB() const {
-  DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
   ConsensusStatePB cstate;
-  cstate.set_current_term(pb_.current_term());
+  ToConsensusStatePB(&cstate);
+  return cstate;
+}
+
+void ConsensusMetadata::ToConsensusStatePB(ConsensusStatePB* cstate) const {
+  cstate->Clear();
+  cstate->set_current_term(pb_.current_term());
   if (!leader_uuid_.empty()) {
-    cstate.set_leader_uuid(leader_uuid_);
+    cstate->set_leader_uuid(leader_uuid_);
   }
-  *cstate.mutable_committed_config() = CommittedConfig();
+  *cstate->mutable_committed_config() = CommittedConfig();
   if (has_pending_config_) {
-    *cstate.mutable_pending_config() = pending_config_;
+    *cstate->mutable_pending_config() = pending_config_;
   }
-  return cstate;
 }
 
 void ConsensusMetadata::MergeCommittedConsensusStatePB(const ConsensusStatePB& cstate) {
@@ -291,24 +282,40 @@ Status ConsensusMetadata::Flush(FlushMode flush_mode) {
   RETURN_NOT_OK_PREPEND(VerifyRaftConfig(pb_.committed_config()),
                         "Invalid config in ConsensusMetadata, cannot flush to disk");
 
-  // Create directories if needed.
-  string dir = fs_manager_->GetConsensusMetadataDir();
-  bool created_dir = false;
-  RETURN_NOT_OK_PREPEND(env_util::CreateDirIfMissing(
-      fs_manager_->env(), dir, &created_dir),
-                        "Unable to create consensus metadata root dir");
-  // fsync() parent dir if we had to create the dir.
-  if (PREDICT_FALSE(created_dir)) {
-    string parent_dir = DirName(dir);
-    RETURN_NOT_OK_PREPEND(Env::Default()->SyncDir(parent_dir),
-                          "Unable to fsync consensus parent dir " + parent_dir);
+  // If the metadata is byte-for-byte identical to what was last loaded from
+  // or flushed to disk, the on-disk state already reflects it: skip the
+  // rewrite and, more importantly, its fsync. Election sequences commonly
+  // re-flush an unchanged term or vote.
+  string pb_bytes = pb_.SerializeAsString();
+  if (flush_mode == OVERWRITE &&
+      !last_flushed_pb_bytes_.empty() &&
+      pb_bytes == last_flushed_pb_bytes_) {
+    return Status::OK();
+  }
+
+  // Create directories if needed. Once we've seen the directory exist we
+  // don't re-check it on subsequent flushes: the check is a syscall on the
+  // durable-state hot path, and if the directory disappears out from under
+  // us the write below fails anyway.
+  if (PREDICT_FALSE(!cmeta_dir_created_)) {
+    bool created_dir = false;
+    RETURN_NOT_OK_PREPEND(env_util::CreateDirIfMissing(
+        fs_manager_->env(), cmeta_dir_, &created_dir),
+                          "Unable to create consensus metadata root dir");
+    // fsync() parent dir if we had to create the dir.
+    if (PREDICT_FALSE(created_dir)) {
+      string parent_dir = DirName(cmeta_dir_);
+      RETURN_NOT_OK_PREPEND(Env::Default()->SyncDir(parent_dir),
+                            "Unable to fsync consensus parent dir " + parent_dir);
+    }
+    cmeta_dir_created_ = true;
   }
 
   const bool cmeta_force_fsync =
       FLAGS_cmeta_force_fsync || (FLAGS_cmeta_fsync_override_on_xfs && fs_manager_->meta_on_xfs());
-  string meta_file_path = fs_manager_->GetConsensusMetadataPath(tablet_id_);
+  uint64_t bytes_written = 0;
   RETURN_NOT_OK_PREPEND(pb_util::WritePBContainerToPath(
-      fs_manager_->env(), meta_file_path, pb_,
+      fs_manager_->env(), cmeta_path_, pb_,
       flush_mode == OVERWRITE ? pb_util::OVERWRITE : pb_util::NO_OVERWRITE,
       // We use FLAGS_log_force_fsync_all here because the consensus metadata is
       // essentially an extension of the primary durability mechanism of the
@@ -319,15 +326,22 @@ Status ConsensusMetadata::Flush(FlushMode flush_mode) {
       // fsync() due to periodic commit with default settings, whereas other
       // filesystems such as XFS will not commit as often and need the fsync to
       // avoid significant data loss when a crash happens.
-      FLAGS_log_force_fsync_all || cmeta_force_fsync ? pb_util::SYNC : pb_util::NO_SYNC),
+      FLAGS_log_force_fsync_all || cmeta_force_fsync ? pb_util::SYNC : pb_util::NO_SYNC,
+      &bytes_written),
           Substitute("Unable to write consensus meta file for tablet $0 to path $1",
-                     tablet_id_, meta_file_path));
-  return UpdateOnDiskSize();
+                     tablet_id_, cmeta_path_));
+  last_flushed_pb_bytes_ = std::move(pb_bytes);
+  flush_write_count_for_tests_++;
+  // We just wrote the file, so we know its size without having to stat() it.
+  on_disk_size_ = bytes_written;
+  return Status::OK();
 }
 
 ConsensusMetadata::RoleAndTerm ConsensusMetadata::GetRoleAndTerm() const {
   // Read the cached role and term atomically to unpack them consistently.
-  const uint64_t val = role_and_term_cache_;
+  // An acquire load pairs with the release store in UpdateRoleAndTermCache();
+  // no stronger ordering is needed on this lock-free read path.
+  const uint64_t val = role_and_term_cache_.load(std::memory_order_acquire);
   return std::make_pair(UnpackRole(val), UnpackTerm(val));
 }
 
@@ -337,8 +351,12 @@ ConsensusMetadata::ConsensusMetadata(FsManager* fs_manager,
     : fs_manager_(CHECK_NOTNULL(fs_manager)),
       tablet_id_(std::move(tablet_id)),
       peer_uuid_(std::move(peer_uuid)),
+      cmeta_dir_(fs_manager_->GetConsensusMetadataDir()),
+      cmeta_path_(fs_manager_->GetConsensusMetadataPath(tablet_id_)),
       has_pending_config_(false),
+      cmeta_dir_created_(false),
       flush_count_for_tests_(0),
+      flush_write_count_for_tests_(0),
       active_role_(RaftPeerPB::UNKNOWN_ROLE),
       on_disk_size_(0) {
   UpdateRoleAndTermCache();
@@ -378,6 +396,9 @@ Status ConsensusMetadata::Load(FsManager* fs_manager,
                                                  fs_manager->GetConsensusMetadataPath(tablet_id),
                                                  &cmeta->pb_));
   cmeta->UpdateActiveRole(); // Needs to happen here as we sidestep the accessor APIs.
+  // Remember the loaded bytes so that a subsequent Flush() of unchanged
+  // metadata can skip the rewrite.
+  cmeta->last_flushed_pb_bytes_ = cmeta->pb_.SerializeAsString();
 
   RETURN_NOT_OK(cmeta->UpdateOnDiskSize());
   if (cmeta_out) *cmeta_out = std::move(cmeta);
@@ -399,23 +420,30 @@ std::string ConsensusMetadata::LogPrefix() const {
 
 void ConsensusMetadata::UpdateActiveRole() {
   DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
-  active_role_ = GetConsensusRole(peer_uuid_, leader_uuid_, ActiveConfig());
+  active_role_ = GetConsensusRole(peer_uuid_, leader_uuid_, active_config());
   UpdateRoleAndTermCache();
-  VLOG_WITH_PREFIX(1) << "Updating active role to " << RaftPeerPB::Role_Name(active_role_)
-                      << ". Consensus state: "
-                      << pb_util::SecureShortDebugString(ToConsensusStatePB());
+  // Guard explicitly on the vlog level: building the debug string deep-copies
+  // the committed config, and this runs on every setter call.
+  if (VLOG_IS_ON(1)) {
+    VLOG_WITH_PREFIX(1) << "Updating active role to " << RaftPeerPB::Role_Name(active_role_)
+                        << ". Consensus state: "
+                        << pb_util::SecureShortDebugString(ToConsensusStatePB());
+  }
 }
 
 void ConsensusMetadata::UpdateRoleAndTermCache() {
   DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
-  role_and_term_cache_ = PackRoleAndTerm(
-      active_role_, pb_.has_current_term() ? current_term() : -1);
+  // Read the term from pb_ directly rather than via the current_term()
+  // accessor: the accessor re-acquires the collision warner's lock and
+  // DCHECKs the field's presence, which we've already checked here.
+  role_and_term_cache_.store(
+      PackRoleAndTerm(active_role_, pb_.has_current_term() ? pb_.current_term() : -1),
+      std::memory_order_release);
 }
 
 Status ConsensusMetadata::UpdateOnDiskSize() {
-  string path = fs_manager_->GetConsensusMetadataPath(tablet_id_);
   uint64_t on_disk_size;
-  RETURN_NOT_OK(fs_manager_->env()->GetFileSize(path, &on_disk_size));
+  RETURN_NOT_OK(fs_manager_->env()->GetFileSize(cmeta_path_, &on_disk_size));
   on_disk_size_ = on_disk_size;
   return Status::OK();
 }
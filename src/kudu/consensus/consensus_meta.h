@@ -21,6 +21,7 @@
 #include <string>
 #include <utility>
 
+#include <glog/logging.h>
 #include <gtest/gtest_prod.h>
 
 #include "kudu/consensus/metadata.pb.h"
@@ -67,6 +68,11 @@ enum class ConsensusMetadataCreateMode {
 // configuration.
 //
 // This class is not thread-safe and requires external synchronization.
+// Mutating methods (and Flush()) are instrumented with a debug-only
+// thread collision warner to catch violations; the const read accessors
+// are not, and rely entirely on the caller's synchronization. The one
+// exception is GetRoleAndTerm(), which is safe to call without
+// synchronization via its lock-free cache.
 class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
  public:
 
@@ -90,18 +96,18 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
 
   // Returns true iff peer with specified uuid is a voter in the specified
   // local Raft config.
-  bool IsVoterInConfig(const std::string& uuid, RaftConfigState type);
+  bool IsVoterInConfig(const std::string& uuid, RaftConfigState type) const;
 
   // Returns true iff peer with specified uuid is a member of the specified
   // local Raft config.
-  bool IsMemberInConfig(const std::string& uuid, RaftConfigState type);
+  bool IsMemberInConfig(const std::string& uuid, RaftConfigState type) const;
 
   // Returns a count of the number of voters in the specified local Raft
   // config.
-  int CountVotersInConfig(RaftConfigState type);
+  int CountVotersInConfig(RaftConfigState type) const;
 
   // Returns the opid_index of the specified local Raft config.
-  int64_t GetConfigOpIdIndex(RaftConfigState type);
+  int64_t GetConfigOpIdIndex(RaftConfigState type) const;
 
   // Accessors for committed configuration.
   const RaftConfigPB& CommittedConfig() const;
@@ -136,6 +142,15 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
   // leader_uuid field of the returned ConsensusStatePB will be cleared.
   ConsensusStatePB ToConsensusStatePB() const;
 
+  // Out-parameter variant of the above: clears and fills in 'cstate' in
+  // place. Useful for callers that already have a ConsensusStatePB to
+  // populate, avoiding an extra message move.
+  //
+  // NOTE: callers that only need the committed config or the pending
+  // flag should prefer CommittedConfig() / has_pending_config(), which
+  // avoid copying the config entirely.
+  void ToConsensusStatePB(ConsensusStatePB* cstate) const;
+
   // Merge the committed portion of the consensus state from the source node
   // during tablet copy.
   //
@@ -158,6 +173,13 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
     return flush_count_for_tests_;
   }
 
+  // The number of times Flush() actually rewrote the file, as opposed to
+  // returning early because the metadata was unchanged since the last
+  // Load() or Flush(). Always <= flush_count_for_tests().
+  int64_t flush_write_count_for_tests() const {
+    return flush_write_count_for_tests_;
+  }
+
   // The on-disk size of the consensus metadata, as of the last call to
   // Load() or Flush(). This method is thread-safe.
   int64_t on_disk_size() const {
@@ -177,6 +199,8 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
   FRIEND_TEST(ConsensusMetadataTest, TestCreateNoOverwrite);
   FRIEND_TEST(ConsensusMetadataTest, TestFailedLoad);
   FRIEND_TEST(ConsensusMetadataTest, TestFlush);
+  FRIEND_TEST(ConsensusMetadataTest, TestFlushSkippedWhenUnchanged);
+  FRIEND_TEST(ConsensusMetadataTest, TestFlushSkippedWhenUnchangedAfterLoad);
   FRIEND_TEST(ConsensusMetadataTest, TestActiveRole);
   FRIEND_TEST(ConsensusMetadataTest, TestToConsensusStatePB);
   FRIEND_TEST(ConsensusMetadataTest, TestMergeCommittedConsensusStatePB);
@@ -213,6 +237,25 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
   // Return the specified config.
   const RaftConfigPB& GetConfig(RaftConfigState type) const;
 
+  // Inline accessors for the individual config states; GetConfig()
+  // dispatches to these. Hot internal callers (e.g. UpdateActiveRole())
+  // use them directly to avoid the switch.
+  const RaftConfigPB& committed_config() const {
+    DCHECK(pb_.has_committed_config());
+    return pb_.committed_config();
+  }
+
+  const RaftConfigPB& pending_config() const {
+    CHECK(has_pending_config_) << LogPrefix() << "There is no pending config";
+    return pending_config_;
+  }
+
+  // The "active" config: the pending config if one is set, otherwise the
+  // committed config.
+  const RaftConfigPB& active_config() const {
+    return has_pending_config_ ? pending_config_ : committed_config();
+  }
+
   std::string LogPrefix() const;
 
   // Updates the cached active role.
@@ -228,6 +271,13 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
   const std::string tablet_id_;
   const std::string peer_uuid_;
 
+  // The directory containing the consensus metadata and the path of the
+  // metadata file itself. Precomputed at construction time: these are
+  // needed on every Flush(), and building them involves string
+  // concatenation.
+  const std::string cmeta_dir_;
+  const std::string cmeta_path_;
+
   // This fake mutex helps ensure that this ConsensusMetadata object stays
   // externally synchronized.
   DFAKE_MUTEX(fake_lock_);
@@ -238,9 +288,23 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
   // RaftConfig used by the peers when there is a pending config change operation.
   RaftConfigPB pending_config_;
 
+  // Whether Flush() has already ensured that the consensus metadata
+  // directory exists, allowing subsequent flushes to skip the check.
+  bool cmeta_dir_created_;
+
   // The number of times the metadata has been flushed to disk.
   int64_t flush_count_for_tests_;
 
+  // The number of Flush() calls that actually rewrote the file rather than
+  // skipping the write because the metadata was unchanged.
+  int64_t flush_write_count_for_tests_;
+
+  // Serialized form of pb_ as of the last successful Load() or Flush().
+  // Used by Flush() to skip the write and fsync when the metadata hasn't
+  // actually changed. Empty if the metadata has never been on disk in
+  // this process's lifetime.
+  std::string last_flushed_pb_bytes_;
+
   // Durable fields.
   ConsensusMetadataPB pb_;
 
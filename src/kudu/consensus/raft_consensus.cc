@@ -2599,7 +2599,7 @@ Status RaftConsensus::ConsensusState(ConsensusStatePB* cstate,
   if (state_ == kShutdown) {
     return Status::IllegalState("Tablet replica is shutdown");
   }
-  ConsensusStatePB cstate_tmp = cmeta_->ToConsensusStatePB();
+  cmeta_->ToConsensusStatePB(cstate);
 
   // If we need to include the health report, merge it into the committed
   // config iff we believe we are the current leader of the config.
@@ -2612,7 +2612,7 @@ Status RaftConsensus::ConsensusState(ConsensusStatePB* cstate,
 
     // Iterate through each peer in the committed config and attach the health
     // report to it.
-    RaftConfigPB* committed_raft_config = cstate_tmp.mutable_committed_config();
+    RaftConfigPB* committed_raft_config = cstate->mutable_committed_config();
     for (int i = 0; i < committed_raft_config->peers_size(); i++) {
       RaftPeerPB* peer = committed_raft_config->mutable_peers(i);
       const HealthReportPB* report = FindOrNull(reports, peer->permanent_uuid());
@@ -2620,7 +2620,6 @@ Status RaftConsensus::ConsensusState(ConsensusStatePB* cstate,
       *peer->mutable_health_report() = *report;
     }
   }
-  *cstate = std::move(cstate_tmp);
   return Status::OK();
 }
 
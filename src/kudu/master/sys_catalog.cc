@@ -231,8 +231,7 @@ Status SysCatalogTable::VerifyAndPopulateSingleMasterConfig(ConsensusMetadata* c
       // Set the 'last_known_addr' in Raft config for single master configuration.
       *config.mutable_peers(0)->mutable_last_known_addr() = HostPortToPB(master_addr);
       cmeta->set_committed_config(config);
-      ConsensusStatePB cstate = cmeta->ToConsensusStatePB();
-      RETURN_NOT_OK(consensus::VerifyRaftConfig(cstate.committed_config()));
+      RETURN_NOT_OK(consensus::VerifyRaftConfig(cmeta->CommittedConfig()));
       RETURN_NOT_OK_PREPEND(cmeta->Flush(),
                             "Failed to flush consensus metadata on populating "
                             "'last_known_addr' field in consensus metadata");
@@ -265,9 +264,9 @@ Status SysCatalogTable::Load(FsManager *fs_manager) {
   if (!master_->opts().IsDistributed()) {
     RETURN_NOT_OK(VerifyAndPopulateSingleMasterConfig(cmeta.get()));
   } else {
-    ConsensusStatePB cstate = cmeta->ToConsensusStatePB();
-    RETURN_NOT_OK(consensus::VerifyRaftConfig(cstate.committed_config()));
-    CHECK(!cstate.has_pending_config());
+    const RaftConfigPB& committed_config = cmeta->CommittedConfig();
+    RETURN_NOT_OK(consensus::VerifyRaftConfig(committed_config));
+    CHECK(!cmeta->has_pending_config());
 
     // Make sure the set of masters passed in at start time matches the set in
     // the on-disk cmeta.
@@ -282,7 +281,7 @@ Status SysCatalogTable::Load(FsManager *fs_manager) {
                                  JoinStrings(peer_addrs_from_opts, ", "));
     }
     set<string> peer_addrs_from_disk;
-    for (const auto& p : cstate.committed_config().peers()) {
+    for (const auto& p : committed_config.peers()) {
       peer_addrs_from_disk.insert(HostPortFromPB(p.last_known_addr()).ToString());
     }
     vector<string> symm_diff;
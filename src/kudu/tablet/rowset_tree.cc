@@ -27,16 +27,15 @@
 
 #include <glog/logging.h>
 
-#include "kudu/gutil/stl_util.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/interval_tree.h"
 #include "kudu/util/interval_tree-inl.h"
 #include "kudu/util/slice.h"
 
 using std::shared_ptr;
 using std::string;
-using std::unique_ptr;
 using std::vector;
 
 namespace kudu {
@@ -67,13 +66,18 @@ struct QueryStruct {
 
 // Entry for use in the interval tree.
 struct RowSetWithBounds {
-  string min_key;
-  string max_key;
-
+  // The bounds are stored in faststrings rather than std::strings:
+  // encoded bounds are typically short composite keys which fit in the
+  // faststring's 32-byte inline buffer, so the keys examined by every
+  // interval tree compare live directly in the entry rather than behind
+  // a separately-allocated heap buffer.
+  //
   // NOTE: the ordering of struct fields here is purposeful: we access
   // min_key and max_key frequently, so putting them first in the struct
-  // ensures they fill a single 64-byte cache line (each is 32 bytes).
-  // The 'rowset' pointer is accessed comparitively rarely.
+  // keeps them on the entry's first cache lines. The 'rowset' pointer
+  // is accessed comparitively rarely.
+  faststring min_key;
+  faststring max_key;
   RowSet *rowset;
 };
 
@@ -128,18 +132,13 @@ RowSetTree::RowSetTree()
 
 Status RowSetTree::Reset(const RowSetVector &rowsets) {
   CHECK(!initted_);
-  std::vector<RowSetWithBounds *> entries;
-  RowSetVector unbounded;
-  ElementDeleter deleter(&entries);
+  std::vector<RowSetWithBounds> entries;
+  std::vector<RowSet*> unbounded;
   entries.reserve(rowsets.size());
-  std::vector<RSEndpoint> endpoints;
-  endpoints.reserve(rowsets.size()*2);
 
   // Iterate over each of the provided RowSets, fetching their
   // bounds and adding them to the local vectors.
   for (const shared_ptr<RowSet> &rs : rowsets) {
-    unique_ptr<RowSetWithBounds> rsit(new RowSetWithBounds());
-    rsit->rowset = rs.get();
     string min_key;
     string max_key;
     Status s = rs->GetBounds(&min_key, &max_key);
@@ -148,7 +147,7 @@ Status RowSetTree::Reset(const RowSetVector &rowsets) {
       // data gets inserted. Therefore we can't put it in the static
       // interval tree -- instead put it on the list which is consulted
       // on every access.
-      unbounded.push_back(rs);
+      unbounded.push_back(rs.get());
       continue;
     } else if (!s.ok()) {
       LOG(WARNING) << "Unable to construct RowSetTree: "
@@ -160,23 +159,34 @@ Status RowSetTree::Reset(const RowSetVector &rowsets) {
       << "Rowset min must be <= max: " << rs->ToString();
 
     // Load bounds and save entry
-    rsit->min_key = std::move(min_key);
-    rsit->max_key = std::move(max_key);
+    RowSetWithBounds rsit;
+    rsit.rowset = rs.get();
+    rsit.min_key.assign_copy(min_key);
+    rsit.max_key.assign_copy(max_key);
+    entries.emplace_back(std::move(rsit));
+  }
 
-    // Load into key endpoints.
-    endpoints.emplace_back(rsit->rowset, START, rsit->min_key);
-    endpoints.emplace_back(rsit->rowset, STOP, rsit->max_key);
+  // Install the entries. This must happen before building the endpoint
+  // list and the interval tree below: both hold Slices/pointers into
+  // 'entries_', which is not resized again after this point.
+  entries_.swap(entries);
 
-    entries.push_back(rsit.release());
+  std::vector<RSEndpoint> endpoints;
+  endpoints.reserve(entries_.size() * 2);
+  std::vector<RowSetWithBounds *> tree_entries;
+  tree_entries.reserve(entries_.size());
+  for (RowSetWithBounds& entry : entries_) {
+    endpoints.emplace_back(entry.rowset, START, entry.min_key);
+    endpoints.emplace_back(entry.rowset, STOP, entry.max_key);
+    tree_entries.push_back(&entry);
   }
 
   // Sort endpoints
   std::sort(endpoints.begin(), endpoints.end(), RSEndpointBySliceCompare);
 
   // Install the vectors into the object.
-  entries_.swap(entries);
   unbounded_rowsets_.swap(unbounded);
-  tree_.reset(new IntervalTree<RowSetIntervalTraits>(entries_));
+  tree_.reset(new IntervalTree<RowSetIntervalTraits>(tree_entries));
   key_endpoints_.swap(endpoints);
   all_rowsets_.assign(rowsets.begin(), rowsets.end());
 
@@ -198,15 +208,16 @@ void RowSetTree::FindRowSetsIntersectingInterval(const boost::optional<Slice>& l
                                                  vector<RowSet*>* rowsets) const {
   DCHECK(initted_);
 
+  // Reserve the worst case up front (every rowset matches) so the appends
+  // below never trigger a geometric growth-and-copy.
+  rowsets->reserve(rowsets->size() + unbounded_rowsets_.size() + entries_.size());
+
   // All rowsets with unknown bounds need to be checked.
-  for (const shared_ptr<RowSet> &rs : unbounded_rowsets_) {
-    rowsets->push_back(rs.get());
-  }
+  rowsets->insert(rowsets->end(), unbounded_rowsets_.begin(), unbounded_rowsets_.end());
 
   vector<RowSetWithBounds *> from_tree;
-  from_tree.reserve(all_rowsets_.size());
+  from_tree.reserve(entries_.size());
   tree_->FindIntersectingInterval(lower_bound, upper_bound, &from_tree);
-  rowsets->reserve(rowsets->size() + from_tree.size());
   for (RowSetWithBounds *rs : from_tree) {
     rowsets->push_back(rs->rowset);
   }
@@ -216,17 +227,18 @@ void RowSetTree::FindRowSetsWithKeyInRange(const Slice &encoded_key,
                                            vector<RowSet *> *rowsets) const {
   DCHECK(initted_);
 
+  // Reserve the worst case up front (every rowset matches) so the appends
+  // below never trigger a geometric growth-and-copy.
+  rowsets->reserve(rowsets->size() + unbounded_rowsets_.size() + entries_.size());
+
   // All rowsets with unknown bounds need to be checked.
-  for (const shared_ptr<RowSet> &rs : unbounded_rowsets_) {
-    rowsets->push_back(rs.get());
-  }
+  rowsets->insert(rowsets->end(), unbounded_rowsets_.begin(), unbounded_rowsets_.end());
 
   // Query the interval tree to efficiently find rowsets with known bounds
   // whose ranges overlap the probe key.
   vector<RowSetWithBounds *> from_tree;
-  from_tree.reserve(all_rowsets_.size());
+  from_tree.reserve(entries_.size());
   tree_->FindContainingPoint(encoded_key, &from_tree);
-  rowsets->reserve(rowsets->size() + from_tree.size());
   for (RowSetWithBounds *rs : from_tree) {
     rowsets->push_back(rs->rowset);
   }
@@ -239,9 +251,9 @@ void RowSetTree::ForEachRowSetContainingKeys(
   DCHECK(std::is_sorted(encoded_keys.cbegin(), encoded_keys.cend(),
                         Slice::Comparator()));
   // All rowsets with unknown bounds need to be checked.
-  for (const shared_ptr<RowSet> &rs : unbounded_rowsets_) {
+  for (RowSet* rs : unbounded_rowsets_) {
     for (int i = 0; i < encoded_keys.size(); i++) {
-      cb(rs.get(), i);
+      cb(rs, i);
     }
   }
 
@@ -264,7 +276,6 @@ void RowSetTree::ForEachRowSetContainingKeys(
 
 
 RowSetTree::~RowSetTree() {
-  STLDeleteElements(&entries_);
 }
 
 } // namespace tablet
@@ -118,10 +118,11 @@ class RowSetTree {
   // TODO map to usage statistics as well. See KUDU-???
   std::vector<RSEndpoint> key_endpoints_;
 
-  // Container for all of the entries in tree_. IntervalTree does
-  // not itself manage memory, so this provides a simple way to enumerate
-  // all the entry structs and free them in the destructor.
-  std::vector<RowSetWithBounds *> entries_;
+  // Container for all of the entries in tree_. The entries are stored
+  // by value in a contiguous array so that interval tree traversal
+  // doesn't have to chase a pointer per entry. The interval tree nodes
+  // point into this vector, so it is never resized after Reset().
+  std::vector<RowSetWithBounds> entries_;
 
   // All of the rowsets which were put in this RowSetTree.
   RowSetVector all_rowsets_;
@@ -133,8 +134,10 @@ class RowSetTree {
   // are mutable (MemRowSets).
   //
   // These have to be consulted for every access, so are not
-  // stored in the interval tree.
-  RowSetVector unbounded_rowsets_;
+  // stored in the interval tree. Stored as raw pointers so that queries
+  // can bulk-append them to their result vectors; 'all_rowsets_' keeps
+  // the underlying rowsets alive.
+  std::vector<RowSet*> unbounded_rowsets_;
 
   bool initted_;
 };
@@ -790,7 +790,7 @@ Status Tablet::InsertOrUpsertUnlocked(const IOContext* io_context,
   // Now try to op into memrowset. The memrowset itself will return
   // AlreadyPresent if it has already been inserted there.
   Status s = comps->memrowset->Insert(ts, row, op_state->op_id());
-  if (s.ok()) {
+  if (PREDICT_TRUE(s.ok())) {
     op->SetInsertSucceeded(comps->memrowset->mrs_id());
   } else {
     if (s.IsAlreadyPresent()) {
@@ -856,7 +856,7 @@ Status Tablet::ApplyUpsertAsUpdate(const IOContext* io_context,
                                stats,
                                result);
   CHECK(!s.IsNotFound());
-  if (s.ok()) {
+  if (PREDICT_TRUE(s.ok())) {
     if (metrics_) {
       metrics_->upserts_as_updates->Increment();
     }
@@ -1019,44 +1019,53 @@ Status Tablet::BulkCheckPresence(const IOContext* io_context, WriteOpState* op_s
   // so load it up top.
   RowOp* const * row_ops_base = op_state->row_ops().data();
 
-  // Run all of the ops through the RowSetTree.
+  // Run all of the ops through the RowSetTree. While collecting the probe
+  // keys, also detect whether the batch arrived in strictly increasing key
+  // order: bulk loaders and sequential writers commonly send pre-sorted
+  // batches, in which case the sort and the duplicate scan below can be
+  // skipped entirely.
   vector<pair<Slice, int>> keys_and_indexes;
   keys_and_indexes.reserve(num_ops);
+  bool strictly_increasing = true;
   for (int i = 0; i < num_ops; i++) {
     RowOp* op = row_ops_base[i];
     // If the op already failed in validation, or if we've got the original result
     // filled in already during replay, then we don't need to consult the RowSetTree.
     if (op->has_result() || op->orig_result_from_log) continue;
-    keys_and_indexes.emplace_back(op->key_probe->encoded_key_slice(), i);
+    Slice key = op->key_probe->encoded_key_slice();
+    if (strictly_increasing && !keys_and_indexes.empty() &&
+        !(keys_and_indexes.back().first < key)) {
+      strictly_increasing = false;
+    }
+    keys_and_indexes.emplace_back(key, i);
+  }
+
+  if (!strictly_increasing) {
+    // Sort the query points by their probe keys, retaining the equivalent indexes.
+    //
+    // It's important to do a stable-sort here so that the 'unique' call
+    // below retains only the _first_ op the user specified, instead of
+    // an arbitrary one.
+    //
+    // TODO(todd): benchmark stable_sort vs using sort() and falling back to
+    // comparing 'a.second' when a.first == b.first. Some microbenchmarks
+    // seem to indicate stable_sort is actually faster.
+    std::stable_sort(keys_and_indexes.begin(), keys_and_indexes.end(),
+                     [](const pair<Slice, int>& a,
+                        const pair<Slice, int>& b) {
+                       return a.first < b.first;
+                     });
+    // If the batch has more than one operation for the same row, then we can't
+    // use the up-front presence optimization on those operations, since the
+    // first operation may change the result of the later presence-checks.
+    keys_and_indexes.erase(std::unique(
+        keys_and_indexes.begin(), keys_and_indexes.end(),
+        [](const pair<Slice, int>& a,
+           const pair<Slice, int>& b) {
+          return a.first == b.first;
+        }), keys_and_indexes.end());
   }
 
-  // Sort the query points by their probe keys, retaining the equivalent indexes.
-  //
-  // It's important to do a stable-sort here so that the 'unique' call
-  // below retains only the _first_ op the user specified, instead of
-  // an arbitrary one.
-  //
-  // TODO(todd): benchmark stable_sort vs using sort() and falling back to
-  // comparing 'a.second' when a.first == b.first. Some microbenchmarks
-  // seem to indicate stable_sort is actually faster.
-  // TODO(todd): could also consider weaving in a check in the loop above to
-  // see if the incoming batch is already totally-ordered and in that case
-  // skip this sort and std::unique call.
-  std::stable_sort(keys_and_indexes.begin(), keys_and_indexes.end(),
-                   [](const pair<Slice, int>& a,
-                      const pair<Slice, int>& b) {
-                     return a.first < b.first;
-                   });
-  // If the batch has more than one operation for the same row, then we can't
-  // use the up-front presence optimization on those operations, since the
-  // first operation may change the result of the later presence-checks.
-  keys_and_indexes.erase(std::unique(
-      keys_and_indexes.begin(), keys_and_indexes.end(),
-      [](const pair<Slice, int>& a,
-         const pair<Slice, int>& b) {
-        return a.first == b.first;
-      }), keys_and_indexes.end());
-
   // Unzip the keys into a separate array (since the RowSetTree API just wants a vector of
   // Slices)
   vector<Slice> keys(keys_and_indexes.size());
@@ -1351,8 +1360,31 @@ void Tablet::ModifyRowSetTree(const RowSetTree& old_tree,
 
 void Tablet::AtomicSwapRowSets(const RowSetVector &to_remove,
                                const RowSetVector &to_add) {
-  std::lock_guard<rw_spinlock> lock(component_lock_);
-  AtomicSwapRowSetsUnlocked(to_remove, to_add);
+  // Build the replacement RowSetTree outside the critical section:
+  // RowSetTree::Reset() is O(n log n) in the number of rowsets, and doing
+  // that work while holding component_lock_ exclusively would stall every
+  // reader and writer on the tablet for the duration. Instead, snapshot
+  // the current components, build the new tree from the snapshot, and
+  // publish it under the lock only if the rowsets haven't changed in the
+  // meantime (e.g. due to a concurrent flush or compaction); otherwise
+  // rebuild from the fresh snapshot and try again.
+  while (true) {
+    scoped_refptr<TabletComponents> old_components;
+    {
+      shared_lock<rw_spinlock> l(component_lock_);
+      old_components = components_;
+    }
+    auto new_tree(make_shared<RowSetTree>());
+    ModifyRowSetTree(*old_components->rowsets, to_remove, to_add, new_tree.get());
+
+    std::lock_guard<rw_spinlock> lock(component_lock_);
+    if (PREDICT_TRUE(components_->rowsets == old_components->rowsets)) {
+      components_ = new TabletComponents(components_->memrowset,
+                                         components_->txn_memrowsets,
+                                         std::move(new_tree));
+      return;
+    }
+  }
 }
 
 void Tablet::AtomicSwapRowSetsUnlocked(const RowSetVector &to_remove,
@@ -2193,7 +2225,13 @@ Status Tablet::CaptureConsistentIterators(
 
   // Construct all the iterators locally first, so that if we fail
   // in the middle, we don't modify the output arguments.
+  //
+  // Reserve the worst case (one iterator per store) up front so the
+  // appends below don't reallocate; each element carries a unique_ptr
+  // and optional bounds, so growth-and-move is not free.
   vector<IterWithBounds> ret;
+  ret.reserve(1 + components_->txn_memrowsets.size() +
+              components_->rowsets->all_rowsets().size());
 
   // Grab the memrowset iterator.
   {
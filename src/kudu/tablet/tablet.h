@@ -23,7 +23,6 @@
 #include <map>
 #include <memory>
 #include <mutex>
-#include <ostream>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -691,7 +690,8 @@ class Tablet {
                                RowSetTree* new_tree);
 
   // Swap out a set of rowsets, atomically replacing them with the new rowset
-  // under the lock.
+  // under the lock. The replacement RowSetTree is constructed outside the
+  // critical section; only the pointer swap happens under the lock.
   void AtomicSwapRowSets(const RowSetVector &to_remove,
                          const RowSetVector &to_add);
 
@@ -814,6 +814,17 @@ class Tablet {
   // Lock protecting the selection of rowsets for compaction.
   // Only one thread may run the compaction selection algorithm at a time
   // so that they don't both try to select the same rowset.
+  //
+  // Lock ordering notes:
+  // - For rowsets visible in the rowset tree (i.e. candidates for
+  //   compaction selection), compact_flush_lock() may only be acquired
+  //   while holding this lock. This guarantees that a rowset selected for
+  //   compaction is still available to lock. The exception is the flush
+  //   path: ReplaceMemRowSetsUnlocked() locks a MemRowSet's
+  //   compact_flush_lock() before publishing it into the tree, which is
+  //   safe because selection can never have seen that rowset unlocked.
+  // - component_lock_ (in shared mode) may be acquired while holding this
+  //   lock, but not vice versa.
   mutable std::mutex compact_select_lock_;
 
   // We take this lock when flushing the tablet's rowsets in Tablet::Flush.  We
@@ -239,6 +239,11 @@ inline bool BloomFilter::MayContainKey(const BloomKeyProbe &probe) const {
   // Basic unrolling by 2s gives a small benefit here since the two bit positions
   // can be calculated in parallel -- it's a 50% chance that the first will be
   // set even if it's a bloom miss, in which case we can parallelize the load.
+  //
+  // NOTE: the bitwise '&' here is deliberate: with a short-circuiting '&&'
+  // the second load would be control-dependent on the first test, serializing
+  // the two cache accesses and adding a poorly-predicted branch. The bitwise
+  // form issues both loads independently and tests them with one branch.
   int rem_hashes = n_hashes_;
   while (rem_hashes >= 2) {
     uint32_t bitpos1 = PickBit(h, n_bits_);
@@ -246,8 +251,8 @@ inline bool BloomFilter::MayContainKey(const BloomKeyProbe &probe) const {
     uint32_t bitpos2 = PickBit(h, n_bits_);
     h = probe.MixHash(h);
 
-    if (!BitmapTest(&bitmap_[0], bitpos1) ||
-        !BitmapTest(&bitmap_[0], bitpos2)) {
+    if (!(BitmapTest(&bitmap_[0], bitpos1) &
+          BitmapTest(&bitmap_[0], bitpos2))) {
       return false;
     }
 
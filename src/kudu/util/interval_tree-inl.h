@@ -106,7 +106,11 @@ void IntervalTree<Traits>::Partition(const IntervalVector &in,
     endpoints.push_back(Traits::get_left(interval));
     endpoints.push_back(Traits::get_right(interval));
   }
-  std::sort(endpoints.begin(), endpoints.end(), LessThan<Traits>);
+  // Only the median endpoint is needed, so select it with nth_element
+  // rather than fully sorting: selection is O(n) per tree level instead
+  // of O(n lg n), and yields the same split point.
+  std::nth_element(endpoints.begin(), endpoints.begin() + endpoints.size() / 2,
+                   endpoints.end(), LessThan<Traits>);
   *split_point = endpoints[endpoints.size() / 2];
 
   // Partition into the groups based on the determined split point.
@@ -72,6 +72,7 @@
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
+#include "kudu/util/threadlocal.h"
 
 using google::protobuf::Descriptor;
 using google::protobuf::DescriptorPool;
@@ -463,6 +464,28 @@ Status ReadSupplementalHeader(ReadableFileType* reader, int version,
   return Status::OK();
 }
 
+
+// Limits the memory retained across calls by a per-thread serialization
+// scratch buffer. On destruction, if the buffer's capacity has grown past
+// a threshold (e.g. after serializing an unusually large message), the
+// backing storage is released so that the thread doesn't pin it forever.
+class ScratchBufferShrinker {
+ public:
+  explicit ScratchBufferShrinker(faststring* buf) : buf_(buf) {}
+  ~ScratchBufferShrinker() {
+    if (PREDICT_FALSE(buf_->capacity() > kMaxRetainedCapacity)) {
+      buf_->clear();
+      buf_->shrink_to_fit();
+    }
+  }
+
+ private:
+  static constexpr size_t kMaxRetainedCapacity = 64 * 1024;
+  faststring* buf_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScratchBufferShrinker);
+};
+
 } // anonymous namespace
 
 void AppendToString(const MessageLite &msg, faststring *output) {
@@ -689,23 +712,25 @@ Status WritablePBContainerFile::CreateNew(const Message& msg) {
   const uint64_t kHeaderLen = (version_ == 1) ? kPBContainerV1HeaderLen
                                               : kPBContainerV1HeaderLen + kPBContainerChecksumLen;
 
-  faststring buf;
-  buf.resize(kHeaderLen);
+  // Serialize into a per-thread scratch buffer; see Append() for rationale.
+  BLOCK_STATIC_THREAD_LOCAL(faststring, buf);
+  ScratchBufferShrinker shrinker(buf);
+  buf->resize(kHeaderLen);
 
   // Serialize the magic.
-  strings::memcpy_inlined(buf.data(), kPBContainerMagic, kPBContainerMagicLen);
+  strings::memcpy_inlined(buf->data(), kPBContainerMagic, kPBContainerMagicLen);
   uint64_t offset = kPBContainerMagicLen;
 
   // Serialize the version.
-  InlineEncodeFixed32(buf.data() + offset, version_);
+  InlineEncodeFixed32(buf->data() + offset, version_);
   offset += sizeof(uint32_t);
   DCHECK_EQ(kPBContainerV1HeaderLen, offset)
     << "Serialized unexpected number of total bytes";
 
   // Versions >= 2: Checksum the magic and version.
   if (version_ >= 2) {
-    uint32_t header_checksum = crc::Crc32c(buf.data(), offset);
-    InlineEncodeFixed32(buf.data() + offset, header_checksum);
+    uint32_t header_checksum = crc::Crc32c(buf->data(), offset);
+    InlineEncodeFixed32(buf->data() + offset, header_checksum);
     offset += sizeof(uint32_t);
   }
   DCHECK_EQ(offset, kHeaderLen);
@@ -715,11 +740,11 @@ Status WritablePBContainerFile::CreateNew(const Message& msg) {
   PopulateDescriptorSet(msg.GetDescriptor()->file(),
                         sup_header.mutable_protos());
   sup_header.set_pb_type(msg.GetTypeName());
-  RETURN_NOT_OK_PREPEND(AppendMsgToBuffer(sup_header, &buf),
+  RETURN_NOT_OK_PREPEND(AppendMsgToBuffer(sup_header, buf),
                         "Failed to prepare supplemental header for writing");
 
   // Write the serialized buffer to the file.
-  RETURN_NOT_OK_PREPEND(AppendBytes(buf),
+  RETURN_NOT_OK_PREPEND(AppendBytes(*buf),
                         "Failed to append header to file");
   state_ = FileState::OPEN;
   return Status::OK();
@@ -747,10 +772,17 @@ Status WritablePBContainerFile::AppendBytes(const Slice& data) {
 Status WritablePBContainerFile::Append(const Message& msg) {
   DCHECK_EQ(FileState::OPEN, state_);
 
-  faststring buf;
-  RETURN_NOT_OK_PREPEND(AppendMsgToBuffer(msg, &buf),
+  // Serialize into a per-thread scratch buffer rather than a fresh
+  // faststring: any record larger than the 32-byte inline buffer would
+  // otherwise heap-allocate, and metadata flush paths funnel through here
+  // at high frequency. The shrinker caps how much memory an unusually
+  // large record can leave pinned to the thread.
+  BLOCK_STATIC_THREAD_LOCAL(faststring, buf);
+  ScratchBufferShrinker shrinker(buf);
+  buf->clear();
+  RETURN_NOT_OK_PREPEND(AppendMsgToBuffer(msg, buf),
                         "Failed to prepare buffer for writing");
-  RETURN_NOT_OK_PREPEND(AppendBytes(buf), "Failed to append data to file");
+  RETURN_NOT_OK_PREPEND(AppendBytes(*buf), "Failed to append data to file");
 
   return Status::OK();
 }
@@ -1055,7 +1087,8 @@ Status ReadPBContainerFromPath(Env* env, const std::string& path, Message* msg)
 Status WritePBContainerToPath(Env* env, const std::string& path,
                               const Message& msg,
                               CreateMode create,
-                              SyncMode sync) {
+                              SyncMode sync,
+                              uint64_t* bytes_written) {
   TRACE_EVENT2("io", "WritePBContainerToPath",
                "path", path,
                "msg_type", msg.GetTypeName());
@@ -1079,6 +1112,9 @@ Status WritePBContainerToPath(Env* env, const std::string& path,
   if (sync == pb_util::SYNC) {
     RETURN_NOT_OK(pb_file.Sync());
   }
+  if (bytes_written) {
+    *bytes_written = pb_file.Offset();
+  }
   RETURN_NOT_OK(pb_file.Close());
   RETURN_NOT_OK_PREPEND(env->RenameFile(tmp_path, path),
                         "Failed to rename tmp file to " + path);
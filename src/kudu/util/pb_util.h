@@ -475,10 +475,13 @@ Status ReadPBContainerFromPath(Env* env, const std::string& path,
 //
 // If create == NO_OVERWRITE and 'path' already exists, the function will fail.
 // If sync == SYNC, the newly created file will be fsynced before returning.
+// If 'bytes_written' is non-null, on success it is set to the resulting
+// file's size, saving callers that track on-disk sizes a stat() call.
 Status WritePBContainerToPath(Env* env, const std::string& path,
                               const google::protobuf::Message& msg,
                               CreateMode create,
-                              SyncMode sync);
+                              SyncMode sync,
+                              uint64_t* bytes_written = nullptr);
 
 // Wrapper for a protobuf message which lazily converts to JSON when
 // the trace buffer is dumped.